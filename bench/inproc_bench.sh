@@ -0,0 +1,39 @@
+#!/bin/sh
+# Time the testcase2 pipeline shape with cat and echo run as processes
+# and as shell threads (-F)
+# usage: inproc_bench.sh <npshell> [runs]
+
+SHELL_BIN=${1:-./npshell}
+RUNS=${2:-20}
+SCRIPT=$(mktemp)
+trap 'rm -f "$SCRIPT"' EXIT
+
+# One line of echo piped through 1000 cats, then a short one
+{
+    echo "setenv PATH /usr/bin:/bin"
+    printf 'echo "aa"'
+    i=0
+    while [ $i -lt 1000 ]; do
+        printf ' | cat'
+        i=$((i + 1))
+    done
+    echo
+    echo "echo hello | cat | cat | wc -c"
+} > "$SCRIPT"
+
+run() {
+    start=$(date +%s%N)
+    i=0
+    while [ $i -lt "$RUNS" ]; do
+        "$SHELL_BIN" "$@" -f "$SCRIPT" > /dev/null < /dev/null
+        i=$((i + 1))
+    done
+    end=$(date +%s%N)
+    echo $(( (end - start) / RUNS / 1000 ))
+}
+
+proc=$(run)
+inproc=$(run -F)
+
+echo "process: ${proc} us/run"
+echo "thread:  ${inproc} us/run"
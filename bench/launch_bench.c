@@ -0,0 +1,76 @@
+// Per-stage launch latency of LAUNCH_SPAWN against LAUNCH_FORK
+//
+// usage: launch_bench [stages] [heap MiB]
+//
+// Every stage is a `true` whose stdout is wired to a pipe, the same
+// way cmd_run wires an ordinary pipe. The heap is filled first since
+// the cost of fork grows with the memory mapped by the shell.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+
+#include "launch.h"
+
+static double now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static double run(int mode, int stages)
+{
+    char *argv[] = {"true", NULL};
+    launch_attr attr;
+    double start, total = 0;
+    int fd[2];
+    pid_t pid;
+
+    launch_mode = mode;
+
+    for (int i = 0; i < stages; ++i) {
+        pipe(fd);
+
+        launch_attr_init(&attr);
+        attr.fd_out = fd[1];
+        attr.close_fds = &fd[0];
+        attr.close_len = 1;
+
+        start = now_us();
+        pid = launch("true", argv, &attr);
+        total += now_us() - start;
+
+        close(fd[0]);
+        close(fd[1]);
+
+        if (pid == -1) {
+            perror("launch");
+            exit(1);
+        }
+        waitpid(pid, NULL, 0);
+    }
+
+    return total / stages;
+}
+
+int main(int argc, char **argv)
+{
+    int stages = argc > 1 ? atoi(argv[1]) : 1500;
+    size_t heap = (argc > 2 ? atoi(argv[2]) : 0) * (size_t)(1 << 20);
+    char *mem;
+
+    if (heap) {
+        mem = malloc(heap);
+        memset(mem, 1, heap);
+    }
+
+    printf("stages: %d, heap: %zu MiB\n", stages, heap >> 20);
+    printf("fork : %8.2f us/stage\n", run(LAUNCH_FORK, stages));
+    printf("spawn: %8.2f us/stage\n", run(LAUNCH_SPAWN, stages));
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+// Tokenizer throughput on command line files
+//
+// usage: lex_bench [rounds] file...
+//
+// Compares the strtok + strdup splitting cmd_parse used to do against
+// lexer_split, which slices the line in place.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lexer.h"
+
+static double now_s(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static char* read_file(const char *path, long *len)
+{
+    FILE *f = fopen(path, "rb");
+    char *buf;
+
+    if (!f) {
+        perror(path);
+        exit(1);
+    }
+
+    fseek(f, 0, SEEK_END);
+    *len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    buf = malloc(*len + 1);
+    *len = fread(buf, 1, *len, f);
+    buf[*len] = 0;
+    fclose(f);
+
+    return buf;
+}
+
+// Run fn over every line of text, on a scratch copy
+static double run(char *text, long len, int rounds,
+                  int (*fn)(char *line, int len, token *tokens))
+{
+    char *scratch = malloc(len + 1);
+    token *tokens = malloc(sizeof(token) * (len / 2 + 2));
+    double start, total = 0;
+    long sink = 0;
+
+    for (int r = 0; r < rounds; ++r) {
+        char *line, *end;
+
+        memcpy(scratch, text, len + 1);
+
+        start = now_s();
+        for (line = scratch; line < scratch + len; line = end + 1) {
+            end = strchr(line, '\n');
+            if (!end)
+                end = scratch + len;
+            *end = 0;
+
+            sink += fn(line, end - line, tokens);
+        }
+        total += now_s() - start;
+    }
+
+    free(scratch);
+    free(tokens);
+
+    if (!sink)
+        printf("(no tokens)\n");
+
+    return len * (double)rounds / total / (1 << 20);
+}
+
+static int strtok_split(char *line, int len, token *tokens)
+{
+    char *tk;
+    char *arg1 = line;
+    char **dup = (char **)tokens;
+    int cnt = 0;
+
+    while ((tk = strtok(arg1, " ")) != NULL) {
+        arg1 = NULL;
+        dup[cnt++] = strdup(tk);
+    }
+
+    for (int i = 0; i < cnt; ++i) {
+        free(dup[i]);
+    }
+
+    return cnt;
+}
+
+int main(int argc, char **argv)
+{
+    int rounds;
+    long len;
+    char *text;
+
+    if (argc < 3) {
+        fprintf(stderr, "usage: %s rounds file...\n", argv[0]);
+        return 1;
+    }
+
+    rounds = atoi(argv[1]);
+
+    for (int i = 2; i < argc; ++i) {
+        text = read_file(argv[i], &len);
+
+        printf("%s (%ld bytes)\n", argv[i], len);
+        printf("  strtok+strdup: %8.1f MB/s\n", run(text, len, rounds, strtok_split));
+        printf("  lexer_split  : %8.1f MB/s\n", run(text, len, rounds, lexer_split));
+
+        free(text);
+    }
+
+    return 0;
+}
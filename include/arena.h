@@ -0,0 +1,41 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_CHUNK_SIZE 16384
+
+typedef struct arena_chunk_tag arena_chunk;
+struct arena_chunk_tag {
+    arena_chunk *next;
+    size_t size;
+    char data[];
+};
+
+typedef struct arena_tag arena;
+struct arena_tag {
+    // All chunks, kept across reset
+    arena_chunk *head;
+
+    // Chunk being allocated from
+    arena_chunk *cur;
+    size_t used;
+
+    // Number of chunks ever malloc'ed
+    int malloc_cnt;
+};
+
+extern void arena_init(arena *a);
+
+// Free all chunks
+extern void arena_release(arena *a);
+
+// Bump allocation, the memory lives until arena_reset
+extern void* arena_alloc(arena *a, size_t size);
+
+extern char* arena_strdup(arena *a, const char *str);
+
+// Make all memory available again in O(1), chunks are reused
+extern void arena_reset(arena *a);
+
+#endif
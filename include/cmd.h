@@ -1,34 +1,32 @@
 #ifndef CMD_H
 #define CMD_H
 
-#include "pidlist.h"
+#include "pidset.h"
+#include "npwheel.h"
+#include "linereader.h"
 
 #define PIPE_ORDINARY   1
 #define PIPE_NUM_STDOUT 2
 #define PIPE_NUM_OUTERR 3
 #define PIPE_FIL_STDOUT 4
 
-typedef struct argv_node_tag argv_node;
-struct argv_node_tag {
-    argv_node *next;
-    char *argv;
-};
-
 typedef struct cmd_node_tag cmd_node;
 struct cmd_node_tag {
     // Next pipe command
     cmd_node *next;
 
-    // Command
+    // Command, same as argv[0]
     char *cmd;
 
-    // Arguments
-    argv_node *argv;
+    // NULL-terminated argv, points into the command line
+    char **argv;
 
     // Redirected output path
     char *rd_output;
 
     int cmd_len;
+
+    // Number of arguments, excluding argv[0]
     int argv_len;
 
     // Pipe type
@@ -41,24 +39,42 @@ struct cmd_node_tag {
 
     // Numbered Pipe
     int numbered; 
+
+    // Index in bulitin_cmds, -1 if not a built-in command
+    int builtin;
 };
 
-typedef struct numbered_pipe_node_tag np_node;
-struct numbered_pipe_node_tag {
-    np_node *next;
-    pid_list *plist;
-    int numbered;
-    int fd[2];
+// A launched line, not waited yet
+typedef struct cmd_pending_tag cmd_pending;
+struct cmd_pending_tag {
+    // Pids to wait for, NULL if the line is not waited
+    pid_set *plist;
+
+    // Last command of the line, -1 if it did not start
+    pid_t last_pid;
+
+    // Exit status if last_pid is -1
+    int status;
 };
 
 extern void cmd_init();
 
-// Read line to cmd_line buffer
+// Read a line from lr, *cmd_line points into the buffer of lr
 // return the length of bytes received
-extern int cmd_read(char *cmd_line);
+extern int cmd_read(line_reader *lr, char **cmd_line);
+
+// Parse cmd_line of len bytes, cmd_line is modified in place
+// and must outlive the returned command
+extern cmd_node* cmd_parse(char *cmd_line, int len);
+
+// Start the line, the next line may be parsed once this returns
+extern void cmd_launch(cmd_node *cmd, cmd_pending *pending);
 
-extern cmd_node* cmd_parse(char *cmd_line);
+// Wait for a launched line
+// return the exit status of its last command
+extern int cmd_wait(cmd_pending *pending);
 
+// cmd_launch and cmd_wait
 extern int cmd_run(cmd_node *cmd);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef EXECCACHE_H
+#define EXECCACHE_H
+
+typedef struct exec_entry_tag exec_entry;
+struct exec_entry_tag {
+    exec_entry *next;
+
+    // Command name
+    char *name;
+
+    // Resolved path, NULL if the command is not found
+    char *path;
+
+    // O_PATH fd of path for execveat, -1 if not opened
+    int fd;
+};
+
+// Resolve cmd the way execvp searches PATH
+// return the cached entry, entry->path is NULL for an unknown command
+extern exec_entry* excache_lookup(const char *cmd);
+
+// Drop all entries, e.g. after PATH is changed
+extern void excache_flush(void);
+
+// Drop all entries if PATH or the mtime of its directories changed
+extern void excache_revalidate(void);
+
+#endif
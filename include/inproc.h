@@ -0,0 +1,22 @@
+#ifndef INPROC_H
+#define INPROC_H
+
+// In-shell implementations of pass-through commands, run as threads
+// moving data between the pipes of the stage instead of processes.
+// Opt-in, off unless inproc_enabled is set.
+extern int inproc_enabled;
+
+// Find an in-shell implementation able to run argv with stdin fd_in
+// (-1 if stdin is not redirected)
+// return its id, -1 if the command must be launched
+extern int inproc_find(char **argv, int fd_in);
+
+// Run implementation id in a detached thread, on duplicates of fd_in
+// and fd_out which the thread closes when done
+// return 0 on success, -1 if the command must be launched instead
+extern int inproc_start(int id, char **argv, int fd_in, int fd_out);
+
+// Number of stages run in the shell
+extern unsigned long inproc_count;
+
+#endif
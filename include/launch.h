@@ -0,0 +1,38 @@
+#ifndef LAUNCH_H
+#define LAUNCH_H
+
+#include <unistd.h>
+
+// Launch engine
+// 1: LAUNCH_SPAWN posix_spawn (clone(CLONE_VM|CLONE_VFORK) in glibc)
+// 2: LAUNCH_FORK  fork + exec, the fallback
+#define LAUNCH_SPAWN 1
+#define LAUNCH_FORK  2
+
+typedef struct launch_attr_tag launch_attr;
+struct launch_attr_tag {
+    // Fds placed on stdin, stdout and stderr of the child
+    // -1: Inherit from the shell
+    int fd_in;
+    int fd_out;
+    int fd_err;
+
+    // Fds closed in the child before the command starts
+    int *close_fds;
+    int close_len;
+
+    // O_PATH fd of the executable for execveat, -1 if none
+    int exec_fd;
+};
+
+extern int launch_mode;
+
+extern void launch_attr_init(launch_attr *attr);
+
+// Start the command with the wiring described by attr
+// return the pid of the child, or -1 with errno set
+//   EAGAIN / ENOMEM: Out of processes, retry later
+//   others         : The command cannot be executed
+extern pid_t launch(char *file, char **argv, launch_attr *attr);
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef LEXER_H
+#define LEXER_H
+
+// Token kind
+// 1: TOKEN_WORD      Command, argument or file path
+// 2: TOKEN_PIPE      |
+// 3: TOKEN_PIPE_NUM  |x
+// 4: TOKEN_PIPE_ERR  !x
+// 5: TOKEN_REDIRECT  >
+#define TOKEN_WORD     1
+#define TOKEN_PIPE     2
+#define TOKEN_PIPE_NUM 3
+#define TOKEN_PIPE_ERR 4
+#define TOKEN_REDIRECT 5
+
+typedef struct token_tag token;
+struct token_tag {
+    // Slice of the command line
+    int offset;
+    int len;
+
+    int kind;
+};
+
+// Split cmd_line into tokens, NUL-terminating each one in place.
+// tokens must have room for (len + 1) / 2 tokens.
+// Reentrant, all state lives in the arguments.
+// return the number of tokens
+extern int lexer_split(char *cmd_line, int len, token *tokens);
+
+#endif
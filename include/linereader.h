@@ -0,0 +1,43 @@
+#ifndef LINEREADER_H
+#define LINEREADER_H
+
+#include <stddef.h>
+
+#define LINEREADER_INIT_SIZE 65536
+
+typedef struct line_reader_tag line_reader;
+struct line_reader_tag {
+    int fd;
+
+    // Grows to hold the longest line seen
+    char *buf;
+    size_t size;
+
+    // Unconsumed bytes are buf[start, end)
+    size_t start;
+    size_t end;
+
+    // buf[start, scan) is known to have no newline
+    size_t scan;
+
+    int eof;
+
+    // Called when idle_fd becomes readable while waiting for input
+    int idle_fd;
+    void (*idle_cb)(void);
+};
+
+extern void lr_init(line_reader *lr, int fd);
+
+extern void lr_release(line_reader *lr);
+
+// Run cb whenever fd is readable while lr is blocked on input
+extern void lr_set_idle(line_reader *lr, int fd, void (*cb)(void));
+
+// Read one line, of any length, "\n" or "\r\n" terminated.
+// *line is NUL-terminated without the line terminator, and stays valid
+// until the next call.
+// return the length of the line, -1 on end of file
+extern int lr_read_line(line_reader *lr, char **line);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef NPRELAY_H
+#define NPRELAY_H
+
+#include <sys/types.h>
+
+// Capacity asked for numbered pipes, while few of them exist
+#define NPRELAY_PIPE_SIZE (256 * 1024)
+#define NPRELAY_GROW_MAX  32
+
+// Bytes moved per splice
+#define NPRELAY_CHUNK (64 * 1024)
+
+// Numbered pipe drained by the relay thread. What writers put in the
+// pipe is spilled to a memfd, so they never block on a pipe nobody reads
+// until the target line.
+typedef struct np_relay_tag np_relay;
+struct np_relay_tag {
+    // Read end of the numbered pipe, -1 once closed
+    int src;
+
+    // Spilled data, -1 until something is written
+    int memfd;
+    loff_t len;
+
+    // Forwarding pipe to the reader after handoff, -1 if none
+    int dst;
+    loff_t sent;
+    loff_t punched;
+
+    int eof;
+};
+
+// Start draining the read end fd of a numbered pipe, the relay owns it
+// from now on
+// return NULL if the pipe must be read as is
+extern np_relay* relay_add(int fd);
+
+// Stop draining r, the writers of the pipe must have been closed by
+// the shell. Data spilled so far is followed by what writers still
+// running write later.
+// return an fd to read the pipe from, owned by the caller
+extern int relay_handoff(np_relay *r);
+
+#endif
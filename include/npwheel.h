@@ -0,0 +1,60 @@
+#ifndef NPWHEEL_H
+#define NPWHEEL_H
+
+#include "pidset.h"
+#include "nprelay.h"
+
+// Lines covered by the wheel, power of 2
+#define NPWHEEL_SIZE 1024
+
+typedef struct numbered_pipe_node_tag np_node;
+struct numbered_pipe_node_tag {
+    // Next pipe in the overflow list
+    np_node *next;
+
+    // All pipes list
+    np_node *all_next;
+    np_node **all_pprev;
+
+    pid_set *plist;
+
+    // Drains the read end until the target line, fd[0] is -1 meanwhile
+    np_relay *relay;
+
+    // Line the pipe is read at
+    unsigned long target;
+
+    int fd[2];
+};
+
+// Timing wheel of numbered pipes, indexed by target line
+typedef struct np_wheel_tag np_wheel;
+struct np_wheel_tag {
+    // Current line
+    unsigned long line;
+
+    // Pipes read within NPWHEEL_SIZE lines, at slots[target % NPWHEEL_SIZE]
+    np_node *slots[NPWHEEL_SIZE];
+
+    // Pipes read later, sorted by target
+    np_node *overflow;
+
+    // All pipes, to reach every write end
+    np_node *all;
+    int len;
+};
+
+extern void npw_init(np_wheel *npw);
+
+// Move to the next line, the pipe read by the last line is released
+// return the pipe read at the new line, NULL if none. Its write end is
+// closed and fd[0] reads all its data.
+extern np_node* npw_advance(np_wheel *npw);
+
+// return the pipe read numbered lines later, NULL if none
+extern np_node* npw_find(np_wheel *npw, int numbered);
+
+// Create the pipe read numbered lines later
+extern np_node* npw_insert(np_wheel *npw, int numbered);
+
+#endif
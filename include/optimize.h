@@ -0,0 +1,20 @@
+#ifndef OPTIMIZE_H
+#define OPTIMIZE_H
+
+#include "cmd.h"
+
+// Log rewrites on stderr
+extern int opt_debug;
+
+// Number of the last line of input, 0 if unknown
+extern unsigned long opt_last_line;
+
+// Rewrite the stages of line number line before they are launched.
+// Argless cat stages between two pipes are elided, and a line whose
+// output goes to a numbered pipe due after opt_last_line is dropped if
+// nothing else can be observed from it. has_np_in tells whether the line
+// reads a numbered pipe.
+// return the new head of cmd, NULL if nothing is left to run
+extern cmd_node* opt_pipeline(cmd_node *cmd, unsigned long line, int has_np_in);
+
+#endif
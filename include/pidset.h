@@ -0,0 +1,78 @@
+#ifndef PIDSET_H
+#define PIDSET_H
+
+#include <unistd.h>
+
+// Slot states, pids are always positive
+#define PSET_EMPTY   0
+#define PSET_DELETED -1
+
+// Smallest table, in slots
+#define PSET_MIN_CAP 16
+
+// Tables of PSET_MIN_CAP << k slots, k < PSET_SLAB_CLASSES, come from
+// the slab, so that sets are recycled without malloc
+#define PSET_SLAB_CLASSES 8
+
+// Bytes preallocated for the slab
+#define PSET_SLAB_SIZE (256 * 1024)
+
+typedef struct pid_slot_tag pid_slot;
+struct pid_slot_tag {
+    pid_t pid;
+
+    // Value attached to pid, e.g. its exit status
+    int val;
+};
+
+// Open addressing set of pids
+typedef struct pid_set_tag pid_set;
+struct pid_set_tag {
+    pid_slot *slots;
+
+    // Power of 2
+    int cap;
+
+    // Number of pids
+    int len;
+
+    // Number of pids and deleted slots
+    int used;
+};
+
+// Reaped pids which are still claimed, valued by exit status
+extern pid_set *closed_plist;
+
+// Preallocate the slab, call once before any other pset_* function
+extern void pset_slab_init(void);
+
+extern pid_set* pset_init();
+
+extern void pset_release(pid_set *pset);
+
+extern void pset_insert(pid_set *pset, pid_t pid);
+
+extern void pset_insert_val(pid_set *pset, pid_t pid, int val);
+
+// return 1 if pid was in pset
+extern int pset_delete(pid_set *pset, pid_t pid);
+
+// Delete pid and store its value to *val
+// return 1 if pid was in pset
+extern int pset_take(pid_set *pset, pid_t pid, int *val);
+
+extern int pset_contains(pid_set *pset, pid_t pid);
+
+extern void pset_clear(pid_set *pset);
+
+// Move all pids of pset2 to pset1, and leave pset2 empty.
+extern void pset_merge(pid_set *pset1, pid_set *pset2);
+
+// Delete the pids which exist in both pset1 and pset2 from both
+extern void pset_delete_intersect(pid_set *pset1, pid_set *pset2);
+
+// Iterate over pids, *pos starts from 0
+// return the next pid, 0 at the end
+extern pid_t pset_next(pid_set *pset, int *pos);
+
+#endif
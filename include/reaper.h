@@ -0,0 +1,31 @@
+#ifndef REAPER_H
+#define REAPER_H
+
+#include <unistd.h>
+
+#include "pidset.h"
+
+// SIGCHLD stays blocked in the shell and is consumed through a
+// signalfd, children are reaped from the main loop only.
+extern void reaper_init(void);
+
+// signalfd, readable when children have exited
+extern int reaper_fd(void);
+
+// Claim pid, it is recorded in closed_plist once it is reaped
+extern void reaper_track(pid_t pid);
+
+// Give up the claims on all pids of pset
+extern void reaper_untrack(pid_set *pset);
+
+// Reap every exited child without blocking
+extern void reaper_drain(void);
+
+// Block until any child exits, then reap as reaper_drain does
+extern void reaper_wait_any(void);
+
+// Block until all pids of pset are reaped, pset is left empty
+// return the exit status of last, 0 if last is not in pset
+extern int reaper_wait(pid_set *pset, pid_t last);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <stddef.h>
+
+// Script file mapped in memory, lines are handed out in place
+typedef struct script_tag script;
+struct script_tag {
+    char *data;
+    size_t size;
+    size_t pos;
+
+    // Copy of a last line without newline, which has no room for NUL
+    char *tail;
+};
+
+// return 0 on success, -1 with errno set
+extern int script_open(script *sc, const char *path);
+
+extern void script_close(script *sc);
+
+// *line is NUL-terminated without "\n" or "\r\n", and stays valid
+// until script_close
+// return the length of the line, -1 at the end of the script
+extern int script_read_line(script *sc, char **line);
+
+// return the number of non-empty lines left in the script
+extern unsigned long script_count_lines(script *sc);
+
+#endif
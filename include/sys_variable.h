@@ -1,7 +1,6 @@
 #ifndef SYS_VARIABLE_H
 #define SYS_VARIABLE_H
 
-#define MAX_CMDLINE_LEN 15001
 #define MAX_CMD_LEN 257
 
 #define STR_HELPER(x) #x
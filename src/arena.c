@@ -0,0 +1,93 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ARENA_ALIGN(x) (((x) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+static arena_chunk* arena_chunk_new(arena *a, size_t size)
+{
+    arena_chunk *chunk;
+
+    if (size < ARENA_CHUNK_SIZE)
+        size = ARENA_CHUNK_SIZE;
+
+    chunk = malloc(sizeof(arena_chunk) + size);
+    chunk->next = NULL;
+    chunk->size = size;
+
+    a->malloc_cnt += 1;
+
+    return chunk;
+}
+
+void arena_init(arena *a)
+{
+    a->head = NULL;
+    a->cur  = NULL;
+    a->used = 0;
+    a->malloc_cnt = 0;
+}
+
+void arena_release(arena *a)
+{
+    arena_chunk *chunk, *next;
+
+    for (chunk = a->head; chunk; chunk = next) {
+        next = chunk->next;
+        free(chunk);
+    }
+
+    a->head = NULL;
+    a->cur  = NULL;
+    a->used = 0;
+}
+
+void* arena_alloc(arena *a, size_t size)
+{
+    arena_chunk *chunk;
+    void *ptr;
+
+    size = ARENA_ALIGN(size);
+
+    if (!a->head) {
+        a->head = a->cur = arena_chunk_new(a, size);
+        a->used = 0;
+    }
+
+    // Move on to the next chunk
+    while (a->used + size > a->cur->size) {
+        if (!a->cur->next) {
+            a->cur->next = arena_chunk_new(a, size);
+        } else if (a->cur->next->size < size) {
+            // Too small for this request, insert a larger one
+            chunk = arena_chunk_new(a, size);
+            chunk->next = a->cur->next;
+            a->cur->next = chunk;
+        }
+
+        a->cur  = a->cur->next;
+        a->used = 0;
+    }
+
+    ptr = a->cur->data + a->used;
+    a->used += size;
+
+    return ptr;
+}
+
+char* arena_strdup(arena *a, const char *str)
+{
+    size_t len = strlen(str) + 1;
+    char *dup = arena_alloc(a, len);
+
+    memcpy(dup, str, len);
+
+    return dup;
+}
+
+void arena_reset(arena *a)
+{
+    a->cur  = a->head;
+    a->used = 0;
+}
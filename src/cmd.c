@@ -9,9 +9,14 @@
 
 #include "sys_variable.h"
 #include "cmd.h"
-#include "pidlist.h"
-
-#define ASCII_SPACE 0x20
+#include "pidset.h"
+#include "reaper.h"
+#include "launch.h"
+#include "execcache.h"
+#include "arena.h"
+#include "lexer.h"
+#include "inproc.h"
+#include "optimize.h"
 
 #define ARR_LEN(x) (sizeof(x)/sizeof(x[0]))
 
@@ -26,80 +31,27 @@ const char *bulitin_cmds[] = {"setenv",
                               "printenv", 
                               "exit"};
 
-const char *special_symbols[] = {">", 
-                                 "|",
-                                 "!"};
-
-static np_node *global_nplist;
-static int use_sh_wait;
-static pid_list *plist;
-sigset_t sigset_SIGCHLD;
-
-static void signal_handler(int signum)
-{
-    int cpid;
-    int ok = 0;
-
-    switch (signum) {
-    case SIGCHLD:
-        if (!use_sh_wait)
-            return;
-
-        // When child process ends, call signal_handler and wait
-        cpid = wait(NULL);
-
-        // Save to update plist
-        ok = plist_delete_by_pid(plist, cpid);
-
-        if (!ok) {
-            plist_insert(sh_closed_plist, cpid);
-        }
-
-        break;
-    default:
-        break;
-    }
-}
-
-// Disable signal handler
-static void disable_sh()
-{
-    sigset_t oldset;
-    sigprocmask(SIG_BLOCK, &sigset_SIGCHLD, &oldset);
-
-    use_sh_wait = 0;
-
-    sigprocmask(SIG_SETMASK, &oldset, NULL);
-}
-
-// Enable signal handler
-static void enable_sh()
-{
-    sigset_t oldset;
-    sigprocmask(SIG_BLOCK, &sigset_SIGCHLD, &oldset);
-
-    use_sh_wait = 1;
+static np_wheel global_npw;
 
-    sigprocmask(SIG_SETMASK, &oldset, NULL);
-}
+// Memory of the command line being parsed and run
+static arena line_arena;
 
 void cmd_init()
 {
-    // Register signal handler
-    signal(SIGCHLD, signal_handler);
+    // Init pid_set and reaper
+    pset_slab_init();
+    reaper_init();
 
-    // Init closed pid_list
-    closed_plist    = plist_init();
-    sh_closed_plist = plist_init();
+    // Stages run in the shell must see EPIPE instead of killing it
+    signal(SIGPIPE, SIG_IGN);
 
-    // Init sigset
-    sigemptyset(&sigset_SIGCHLD);
-    sigaddset(&sigset_SIGCHLD, SIGCHLD);
+    arena_init(&line_arena);
+    npw_init(&global_npw);
 }
 
 static cmd_node* cmd_node_init()
 {
-    cmd_node *node = malloc(sizeof(cmd_node));
+    cmd_node *node = arena_alloc(&line_arena, sizeof(cmd_node));
 
     node->next = NULL;
     node->cmd  = NULL;
@@ -109,41 +61,19 @@ static cmd_node* cmd_node_init()
     node->argv_len = 0;
     node->pipetype = 0;
     node->numbered = 0;
+    node->builtin = -1;
 
     return node;
 }
 
-static void cmd_node_release(cmd_node *cmd)
-{
-    argv_node *cur_an, *next_an;
-
-    if (cmd->cmd)
-        free(cmd->cmd);
-    for (cur_an = cmd->argv; cur_an; cur_an = next_an) {
-        next_an = cur_an->next;
-        free(cur_an->argv);
-        free(cur_an);
-    }
-    if (cmd->rd_output)
-        free(cmd->rd_output);
-    free(cmd);
-}
-
-int cmd_read(char *cmd_line)
+int cmd_read(line_reader *lr, char **cmd_line)
 {
-    int len;
+    int len = lr_read_line(lr, cmd_line);
 
-    if (!fgets(cmd_line, MAX_CMDLINE_LEN, stdin)) {
+    if (len == -1) {
         exit(1);
     }
 
-    len = strlen(cmd_line);
-
-    if (cmd_line[len-1] == '\n') {
-        cmd_line[len-1] = 0;
-        len -= 1;
-    }
-
     return len;
 }
 
@@ -167,86 +97,92 @@ static int valid_filepath(char *filepath)
     return ok;
 }
 
-static int cmd_parse_special_symbols(cmd_node *cmd, char **token_ptr, int ssidx)
+// Parse the special symbol tokens[idx] ending cmd
+// return the index of the next unparsed token
+static int cmd_parse_special_symbols(cmd_node *cmd, char *cmd_line,
+                                     token *tokens, int tokens_len, int idx)
 {
-    // Parse special symbols
-    char *token = *token_ptr;
+    char *tk = &cmd_line[tokens[idx].offset];
     int number;
 
-    switch (ssidx)
+    switch (tokens[idx].kind)
     {
-    case 0:
-        // >
+    case TOKEN_REDIRECT:
         // Stdout redirection (cmd > file)
-        if ((token = strtok(NULL, " ")) != NULL) {
-            cmd->rd_output = strdup(token);
+        if (idx + 1 < tokens_len) {
+            idx += 1;
+            cmd->rd_output = &cmd_line[tokens[idx].offset];
             cmd->pipetype = PIPE_FIL_STDOUT;
-            *token_ptr = token;
         } else {
             // TODO: Report error
         }
         break;
-    
-    case 1:
-        // |
-        if (token[1] == 0) {
-            // Ordinary pipe
-            // cmd1 | cmd2
-            cmd->pipetype = PIPE_ORDINARY;
+
+    case TOKEN_PIPE:
+        // Ordinary pipe
+        // cmd1 | cmd2
+        cmd->pipetype = PIPE_ORDINARY;
+        break;
+
+    case TOKEN_PIPE_NUM:
+        // Numbered pipe
+        // cmd1 |2
+        number = atoi(&tk[1]);
+        if (number <= 0) {
+            // TODO: Report error
         } else {
-            // Numbered pipe
-            // cmd1 |2
-            number = atoi(&token[1]);
-            if (number == 0) {
-                // TODO: Report error
-            } else {
-                cmd->pipetype = PIPE_NUM_STDOUT;
-                cmd->numbered = number;
-            }
+            cmd->pipetype = PIPE_NUM_STDOUT;
+            cmd->numbered = number;
         }
         break;
 
-    case 2:
-        // !
+    case TOKEN_PIPE_ERR:
         // Numbered pipe
         // cmd !2
-        number = atoi(&token[1]);
-        if (number == 0) {
+        number = atoi(&tk[1]);
+        if (number <= 0) {
             // TODO: Report error
         } else {
             cmd->pipetype = PIPE_NUM_OUTERR;
             cmd->numbered = number;
         }
         break;
-    
+
     default:
         break;
     }
 
-    return 0;
+    return idx + 1;
 }
 
-static void cmd_parse_bulitin_cmd(cmd_node *cmd, char *token, int bulitin_cmd_id)
+static void cmd_run_bulitin_cmd(char **args, int args_len, int bulitin_cmd_id)
 {
-    // Parse bulit-in command
-    char *var;
-    char *value;
+    // Run bulit-in command
+    char *var = args_len > 0 ? args[0] : NULL;
+    char *value = args_len > 1 ? args[1] : NULL;
     char *envvalue;
 
     switch (bulitin_cmd_id) {
     case 0:
         // setenv
-        var = strtok(NULL, " ");
-        value = strtok(NULL, " ");
+        if (!var || !value)
+            break;
+
         setenv(var, value, 1);
+
+        if (!strcmp(var, "PATH"))
+            excache_flush();
         break;
     case 1:
         // printenv
-        var = strtok(NULL, " ");
+        if (!var)
+            break;
 
         envvalue = getenv(var);
-        if (envvalue)
+        if (envvalue) {
             printf("%s\n", envvalue);
+            fflush(stdout);
+        }
         break;
     case 2:
         // exit
@@ -255,242 +191,141 @@ static void cmd_parse_bulitin_cmd(cmd_node *cmd, char *token, int bulitin_cmd_id
     }
 }
 
-cmd_node* cmd_parse(char *cmd_line)
+cmd_node* cmd_parse(char *cmd_line, int len)
 {
-    int firstcmd = 1;
     int bulitin_cmd_id = -1;
-    char c;
     int cmd_len = 0;
-    char *strtok_arg1 = cmd_line;
-    char *token;
-    cmd_node *cmd_head;
+    token *tokens;
+    int tokens_len;
+    int idx = 0;
+    int argc;
+    cmd_node *cmd_head = NULL;
     cmd_node *cmd;
     cmd_node **curcmd = &cmd_head;
-    argv_node *argv;
+    char *tk;
 
-    // Parse command
-    while ((token = strtok(strtok_arg1, " ")) != NULL) {
-        argv_node **ptr;
-        int ssidx; // Special symbol idx
+    // Split the line in place, no copy of tokens
+    tokens = arena_alloc(&line_arena, sizeof(token) * ((len + 1) / 2 + 1));
+    tokens_len = lexer_split(cmd_line, len, tokens);
 
-        *curcmd = cmd_node_init();
-        cmd = *curcmd;
-        curcmd = &(cmd->next);
+    // Parse command
+    while (idx < tokens_len) {
+        tk = &cmd_line[tokens[idx].offset];
 
         // Check command is a valid path
-        if (!valid_filepath(token)) {
+        if (!valid_filepath(tk)) {
             // TODO: Report error
             break;
         }
 
-        // Check whether the command is built-in command
-        if (firstcmd) {
-            firstcmd = 0;
-            strtok_arg1 = NULL;
+        // Count argv
+        for (argc = 1; idx + argc < tokens_len; ++argc) {
+            if (tokens[idx + argc].kind != TOKEN_WORD)
+                break;
+        }
+
+        // Make argv, it is passed to exec as is
+        cmd = cmd_node_init();
+        cmd->argv = arena_alloc(&line_arena, sizeof(char *) * (argc + 1));
+        for (int i = 0; i < argc; ++i) {
+            cmd->argv[i] = &cmd_line[tokens[idx + i].offset];
+        }
+        cmd->argv[argc] = NULL;
+        cmd->cmd = cmd->argv[0];
+        cmd->argv_len = argc - 1;
 
+        // Check whether the command is built-in command
+        if (!cmd_head) {
             for (int i = 0; i < ARR_LEN(bulitin_cmds); ++i) {
-                if (!strcmp(bulitin_cmds[i], token)) {
+                if (!strcmp(bulitin_cmds[i], tk)) {
                     bulitin_cmd_id = i;
                     break;
                 }
             }
 
             if (bulitin_cmd_id != -1) {
-                cmd_parse_bulitin_cmd(cmd, token, bulitin_cmd_id);
-                return NULL;
+                // Run later by cmd_launch, in line order
+                cmd->builtin = bulitin_cmd_id;
+                cmd->cmd_len = 1;
+                return cmd;
             }
         }
-        
+
         // Ok, save this command
-        cmd->cmd = strdup(token);
+        *curcmd = cmd;
+        curcmd = &(cmd->next);
         cmd_len += 1;
 
-        // Parse argv
-        ptr = &(cmd->argv); 
-        ssidx = -1;
-        while ((token = strtok(NULL, " ")) != NULL) {
-            c = token[0];
-
-            for (int i = 0; i < ARR_LEN(special_symbols); ++i) {
-                if (special_symbols[i][0] == c) {
-                    // End of argv
-                    ssidx = i;
-                    break;
-                }
-            }
-
-            if (ssidx != -1) {
-                // End of argv
-                break;
-            }
-
-            // Ok, save this argv
-            argv = malloc(sizeof(argv_node));
-            argv->next = NULL;
-            argv->argv = strdup(token);
-
-            *ptr = argv;
-            ptr = &(argv->next);
-
-            cmd->argv_len += 1;
-        }
+        idx += argc;
 
         // Parse special symbol
-        if (token == NULL) {
-            break;
+        if (idx < tokens_len) {
+            idx = cmd_parse_special_symbols(cmd, cmd_line, tokens, tokens_len, idx);
         }
-
-        cmd_parse_special_symbols(cmd, &token, ssidx);
     }
 
-    cmd_head->cmd_len = cmd_len;
+    if (cmd_head)
+        cmd_head->cmd_len = cmd_len;
 
     return cmd_head;
 }
 
-static np_node* fdlist_find_by_numbered(int numbered)
+// Collect write ends of numbered pipes which the child must close,
+// except the one of np_out
+// return the number of fds, *fds has room for two more fds and lives
+// in line_arena
+static int fdlist_make_close_fds(int **fds, np_node *np_out)
 {
-    np_node **fd_ptr;
     np_node *fd_cur;
-    
-    // Find corresponding numbered pipe
-    fd_ptr = &global_nplist;
-    while ((fd_cur = *fd_ptr)) {
-        fd_ptr = &(fd_cur->next);
+    int len = 0;
 
-        if (fd_cur->numbered == numbered) {
-            break;
-        }
-    }
-
-    return fd_cur;
-}
-
-static void fdlist_remove_by_numbered(int numbered)
-{
-    np_node **fd_ptr;
-    np_node *fd_cur;
-    
-    // Find corresponding numbered pipe
-    fd_ptr = &global_nplist;
-    while ((fd_cur = *fd_ptr)) {
-        if (fd_cur->numbered == numbered) {
-            // Keep chain
-            *fd_ptr = fd_cur->next;
-            
-            // Free it
-            if (fd_cur->fd[0] != -1)
-                close(fd_cur->fd[0]);
-            if (fd_cur->fd[1] != -1)
-                close(fd_cur->fd[1]);
-            plist_release(fd_cur->plist);
-            free(fd_cur);
-
-            // End
-            break;
-        } 
-        else {
-            fd_ptr = &(fd_cur->next);
-        }
-    }
-}
+    *fds = arena_alloc(&line_arena, sizeof(int) * (global_npw.len + 2));
 
-static void fdlist_close_all_writeend_except_numbered(int numbered)
-{
-    np_node **fd_ptr;
-    np_node *fd_cur;
-    
-    // Find corresponding numbered pipe
-    fd_ptr = &global_nplist;
-    while ((fd_cur = *fd_ptr)) {
-        fd_ptr = &(fd_cur->next);
-
-        if (fd_cur->numbered != numbered) {
-            close(fd_cur->fd[1]);
-            fd_cur->fd[1] = -1;
+    for (fd_cur = global_npw.all; fd_cur; fd_cur = fd_cur->all_next) {
+        if (fd_cur != np_out && fd_cur->fd[1] != -1) {
+            (*fds)[len++] = fd_cur->fd[1];
         }
     }
-}
-
-static void fdlist_close_all_writeend()
-{
-    np_node **fd_ptr;
-    np_node *fd_cur;
-    
-    // Find corresponding numbered pipe
-    fd_ptr = &global_nplist;
-    while ((fd_cur = *fd_ptr)) {
-        fd_ptr = &(fd_cur->next);
-
-        close(fd_cur->fd[1]);
-        fd_cur->fd[1] = -1;
-    }
-}
-
-static np_node* fdlist_insert(int numbered)
-{
-    np_node **fd_ptr;
-    np_node *fd_cur;
-    np_node *new_np = malloc(sizeof(np_node));
-    new_np->next = NULL;
-    new_np->plist = NULL;
-    new_np->numbered = numbered;
-    pipe(new_np->fd);
-
-    // Insert
-    fd_ptr = &global_nplist;
-    while ((fd_cur = *fd_ptr)) {
-        fd_ptr = &(fd_cur->next);
-    }
-    *fd_ptr = new_np;
 
-    return new_np;
+    return len;
 }
 
-static void fdlist_update()
+void cmd_launch(cmd_node *cmd, cmd_pending *pending)
 {
-    np_node **fd_ptr;
-    np_node *fd_cur;
-    
-    // Find corresponding numbered pipe
-    fd_ptr = &global_nplist;
-    while ((fd_cur = *fd_ptr)) {
-        if (--fd_cur->numbered == -1) {
-            // Keep chain
-            *fd_ptr = fd_cur->next;
-
-            // Free it
-            if (fd_cur->fd[0] != -1)
-                close(fd_cur->fd[0]);
-            if (fd_cur->fd[1] != -1)
-                close(fd_cur->fd[1]);
-            plist_release(fd_cur->plist);
-            free(fd_cur);
-        } 
-        else {
-            fd_ptr = &(fd_cur->next);
-        }
-    }
-}
-
-int cmd_run(cmd_node *cmd)
-{
-    int idx;
     pid_t pid;
     int read_pipe = -1;
     np_node *np_out = NULL;
     cmd_node *next_cmd;
-    char **argv;
     np_node *np_in, *origin_np_in;
+    pid_set *plist;
+    launch_attr attr;
+    int *close_fds;
+    int close_len;
+    int launch_err;
+    int inproc_id;
+    exec_entry *exec;
+
+    pending->plist = NULL;
+    pending->last_pid = -1;
+    pending->status = 0;
+
+    // Bulit-in command
+    if (cmd && cmd->builtin != -1) {
+        cmd_run_bulitin_cmd(&cmd->argv[1], cmd->argv_len, cmd->builtin);
+        cmd = NULL;
+    }
 
-    plist = plist_init();
+    plist = pset_init();
 
-    // Enable signal handler
-    enable_sh();
+    // PATH directories may have changed since the last line
+    if (cmd)
+        excache_revalidate();
 
     // Handle numbered pipe
-    fdlist_update();
-    origin_np_in = np_in = fdlist_find_by_numbered(0);
+    origin_np_in = np_in = npw_advance(&global_npw);
+
+    // Drop no-op stages
+    cmd = opt_pipeline(cmd, global_npw.line, np_in != NULL);
 
     while (cmd) {
         int cur_pipe[2] = {-1, -1};
@@ -508,9 +343,9 @@ int cmd_run(cmd_node *cmd)
         case PIPE_NUM_STDOUT:
         case PIPE_NUM_OUTERR:
             if (cmd->numbered) {
-                np_out = fdlist_find_by_numbered(cmd->numbered);
+                np_out = npw_find(&global_npw, cmd->numbered);
                 if (!np_out) {
-                    np_out = fdlist_insert(cmd->numbered);
+                    np_out = npw_insert(&global_npw, cmd->numbered);
                 }
             }
             break;
@@ -522,12 +357,81 @@ int cmd_run(cmd_node *cmd)
             break;
         }
 
+        // Resolve command
+        exec = excache_lookup(cmd->cmd);
+
+        // Wire fds
+        launch_attr_init(&attr);
+        close_len = fdlist_make_close_fds(&close_fds, np_out);
+
+        if (np_in) {
+            attr.fd_in = np_in->fd[0];
+        } else if (read_pipe != -1) {
+            attr.fd_in = read_pipe;
+        }
+
+        switch(cmd->pipetype) {
+        case PIPE_ORDINARY:
+            close_fds[close_len++] = cur_pipe[0];
+            attr.fd_out = cur_pipe[1];
+            break;
+        case PIPE_NUM_STDOUT:
+            if (np_out->fd[0] != -1)
+                close_fds[close_len++] = np_out->fd[0];
+            attr.fd_out = np_out->fd[1];
+            break;
+        case PIPE_NUM_OUTERR:
+            if (np_out->fd[0] != -1)
+                close_fds[close_len++] = np_out->fd[0];
+            attr.fd_out = np_out->fd[1];
+            attr.fd_err = np_out->fd[1];
+            break;
+        case PIPE_FIL_STDOUT:
+            attr.fd_out = filefd;
+            break;
+        default:
+            // No pipe
+            break;
+        }
+
+        attr.close_fds = close_fds;
+        attr.close_len = close_len;
+        attr.exec_fd = exec->fd;
+
         // Execute command
-        if ((pid = fork()) > 0) {
-            // Parent process
+        if (exec->path && cmd->pipetype == PIPE_ORDINARY && next_cmd &&
+            (inproc_id = inproc_find(cmd->argv, attr.fd_in)) != -1 &&
+            !inproc_start(inproc_id, cmd->argv, attr.fd_in, attr.fd_out)) {
+            // Runs in the shell, no process to wait for
+            pid = 0;
+            launch_err = 0;
+        } else if (exec->path) {
+            pid = launch(exec->path, cmd->argv, &attr);
+            launch_err = (pid == -1) ? errno : 0;
+        } else {
+            // Unknown command, no need to start a process
+            pid = -1;
+            launch_err = ENOENT;
+        }
+
+        if (launch_err && launch_err != EAGAIN && launch_err != ENOMEM) {
+            // Handle error
+            dprintf(attr.fd_err != -1 ? attr.fd_err : STDERR_FILENO,
+                    "Unknown command: [%s].\n", cmd->cmd);
+        }
 
+        if (launch_err != EAGAIN && launch_err != ENOMEM) {
             // Handle pid list
-            plist_insert_block(plist, pid);
+            if (pid > 0) {
+                reaper_track(pid);
+                pset_insert(plist, pid);
+            }
+
+            // Exit status of the line
+            if (!next_cmd) {
+                pending->last_pid = pid;
+                pending->status = launch_err ? 127 : 0;
+            }
 
             // Handle input pipe
             if (read_pipe != -1) {
@@ -549,77 +453,13 @@ int cmd_run(cmd_node *cmd)
                 close(filefd);
             }
 
-            // Free memory
-            cmd_node_release(cmd);
-
             // Go to next command
             cmd = next_cmd;
-        } else if (!pid) {
-            // Child process
-            // Handle another pipe
-            if (np_out) {
-                fdlist_close_all_writeend_except_numbered(cmd->numbered);
-            } else {
-                fdlist_close_all_writeend();
-            }
-
-            // Handle input pipe
-            if (np_in) {
-                dup2(np_in->fd[0], STDIN_FILENO);
-            } else if (read_pipe != -1) {
-                dup2(read_pipe, STDIN_FILENO);
-            }
-            
-            // Handle output pipe
-            switch(cmd->pipetype) {
-            case PIPE_ORDINARY:
-                close(cur_pipe[0]);
-                dup2(cur_pipe[1], STDOUT_FILENO);
-                break;
-            case PIPE_NUM_STDOUT:
-                close(np_out->fd[0]);
-                dup2(np_out->fd[1], STDOUT_FILENO);
-                break;
-            case PIPE_NUM_OUTERR:
-                close(np_out->fd[0]);
-                dup2(np_out->fd[1], STDOUT_FILENO);
-                dup2(np_out->fd[1], STDERR_FILENO);
-                break;
-            case PIPE_FIL_STDOUT:
-                dup2(filefd, STDOUT_FILENO);
-            default:
-                // No pipe
-                break;
-            }
-
-            // Make argv
-            argv = malloc(sizeof(char *) * (cmd->argv_len + 2));
-            argv[0] = cmd->cmd;
-            idx = 1;
-            for (argv_node *an = cmd->argv; an; an = an->next) {
-                argv[idx++] = an->argv;
-            }
-            argv[idx] = NULL;
-
-            // Execute command
-            execvp(cmd->cmd, argv);
-
-            // Handle error
-            fprintf(stderr, "Unknown command: [%s].\n", cmd->cmd);
-            exit(errno);
         } else {
             // Handle error
-            pid_t cpid;
-
-            // Disable signal handler
-            disable_sh();
-
             // Wait for one process and re-run again
-            cpid = wait(NULL);
-
-            // Record closed pid
-            plist_insert(closed_plist, cpid);
-            plist_delete_intersect(plist, closed_plist);
+            reaper_wait_any();
+            pset_delete_intersect(plist, closed_plist);
 
             // Recycle all the resources
             switch(cmd->pipetype) {
@@ -631,9 +471,7 @@ int cmd_run(cmd_node *cmd)
                 break;
             case PIPE_NUM_STDOUT:
             case PIPE_NUM_OUTERR:
-                if (cmd->numbered) {
-                    fdlist_remove_by_numbered(cmd->numbered);
-                }
+                // Keep the numbered pipe, it may hold output of former lines
                 break;
             case PIPE_FIL_STDOUT:
                 if (filefd != -1)
@@ -644,59 +482,63 @@ int cmd_run(cmd_node *cmd)
                 break;
             }
 
-            enable_sh();
-
             // Re-run
         }
     }
 
-    // Disable wait in signal handler
-    disable_sh();
-
-    // close fd
-    if (origin_np_in) {
-        close(origin_np_in->fd[1]);
-        origin_np_in->fd[1] = -1;
-    }
-
-    // Update pid list
-    plist_merge(closed_plist, sh_closed_plist);
-
     if (!np_out) {
-        int status;
-
-        // Wait for origin_np_in
+        // Wait for origin_np_in as well
         if (origin_np_in) {
-            plist_delete_intersect(origin_np_in->plist, closed_plist);
-            for (pid_node *pn = origin_np_in->plist->next; pn; pn = pn->next) {
-                waitpid(pn->pid, &status, 0);
-            }
-        }
-
-        // Wait for plist
-        plist_delete_intersect(plist, closed_plist);
-        for (pid_node *pn = plist->next; pn; pn = pn->next) {
-            waitpid(pn->pid, &status, 0);
+            pset_merge(plist, origin_np_in->plist);
         }
 
-        // Free plist
-        plist_release(plist);
+        // Wait for plist in cmd_wait
+        pending->plist = plist;
     } else {
         // If there is origin_np_in, merge origin_np_in to plist
         if (origin_np_in) {
-            plist_merge(plist, origin_np_in->plist);
+            pset_merge(plist, origin_np_in->plist);
         }
 
         // Update np_out->plist    
         if (!(np_out->plist)) {
             np_out->plist = plist;
         } else {
-            plist_merge(np_out->plist, plist);
-            plist_release(plist);
+            pset_merge(np_out->plist, plist);
+            pset_release(plist);
         }
     }
 
-    enable_sh();
+    // Free memory of this line, the next line may be parsed now
+    arena_reset(&line_arena);
+
+#ifdef DEBUG_ALLOC
+    fprintf(stderr, "[arena] chunks malloc'ed: %d\n", line_arena.malloc_cnt);
+#endif
+}
+
+int cmd_wait(cmd_pending *pending)
+{
+    int status;
+
+    if (!pending->plist)
+        return pending->status;
+
+    status = reaper_wait(pending->plist, pending->last_pid);
+    if (pending->last_pid == -1)
+        status = pending->status;
+
+    pset_release(pending->plist);
+    pending->plist = NULL;
+
+    return status;
+}
+
+int cmd_run(cmd_node *cmd)
+{
+    cmd_pending pending;
+
+    cmd_launch(cmd, &pending);
 
-    return 0;
+    return cmd_wait(&pending);
 }
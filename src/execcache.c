@@ -0,0 +1,219 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "execcache.h"
+
+#define EXCACHE_BUCKETS 256
+
+// Snapshot of one PATH directory
+typedef struct path_dir_tag path_dir;
+struct path_dir_tag {
+    struct timespec mtime;
+    int exist;
+};
+
+static exec_entry *buckets[EXCACHE_BUCKETS];
+static exec_entry uncached;
+
+// PATH the entries were resolved with
+static char *cached_path;
+static path_dir *cached_dirs;
+static int cached_dirs_len;
+
+static unsigned int excache_hash(const char *str)
+{
+    // FNV-1a
+    unsigned int h = 2166136261u;
+
+    while (*str) {
+        h ^= (unsigned char)*str++;
+        h *= 16777619u;
+    }
+
+    return h % EXCACHE_BUCKETS;
+}
+
+static int is_executable(const char *path)
+{
+    struct stat st;
+
+    if (stat(path, &st) || !S_ISREG(st.st_mode))
+        return 0;
+
+    return !access(path, X_OK);
+}
+
+// Copy the PATH element starting at dir to buf
+// return the end of the element
+static const char* path_dir_name(const char *dir, char *buf, int size)
+{
+    const char *end = strchrnul(dir, ':');
+
+    // Empty element means current directory
+    if (end == dir || end - dir >= size) {
+        strcpy(buf, ".");
+    } else {
+        memcpy(buf, dir, end - dir);
+        buf[end - dir] = 0;
+    }
+
+    return end;
+}
+
+// Take a snapshot of the directories in path_env
+static void excache_snapshot(const char *path_env)
+{
+    const char *dir = path_env;
+    const char *end;
+    char buf[4096];
+    struct stat st;
+    int len = 1;
+
+    for (const char *c = path_env; *c; ++c) {
+        if (*c == ':')
+            len += 1;
+    }
+
+    free(cached_path);
+    free(cached_dirs);
+    cached_path = strdup(path_env);
+    cached_dirs = malloc(sizeof(path_dir) * len);
+    cached_dirs_len = len;
+
+    for (int i = 0; i < len; ++i, dir = end + 1) {
+        end = path_dir_name(dir, buf, sizeof(buf));
+
+        cached_dirs[i].exist = !stat(buf, &st);
+        if (cached_dirs[i].exist)
+            cached_dirs[i].mtime = st.st_mtim;
+    }
+}
+
+static char* excache_resolve(const char *cmd)
+{
+    const char *path_env = getenv("PATH");
+    const char *dir;
+    const char *end;
+    int cmd_len = strlen(cmd);
+    char *path;
+
+    if (!path_env)
+        return NULL;
+
+    for (dir = path_env; ; dir = end + 1) {
+        end = strchrnul(dir, ':');
+
+        path = malloc((end - dir) + cmd_len + 3);
+        if (end == dir) {
+            strcpy(path, "./");
+        } else {
+            memcpy(path, dir, end - dir);
+            path[end - dir] = '/';
+            path[end - dir + 1] = 0;
+        }
+        strcat(path, cmd);
+
+        if (is_executable(path))
+            return path;
+
+        free(path);
+
+        if (!*end)
+            break;
+    }
+
+    return NULL;
+}
+
+exec_entry* excache_lookup(const char *cmd)
+{
+    unsigned int h;
+    exec_entry *entry;
+
+    // Paths are not searched in PATH, nothing to cache
+    if (strchr(cmd, '/')) {
+        free(uncached.path);
+        uncached.fd = -1;
+        uncached.path = is_executable(cmd) ? strdup(cmd) : NULL;
+        return &uncached;
+    }
+
+    h = excache_hash(cmd);
+
+    for (entry = buckets[h]; entry; entry = entry->next) {
+        if (!strcmp(entry->name, cmd))
+            return entry;
+    }
+
+    entry = malloc(sizeof(exec_entry));
+    entry->name = strdup(cmd);
+    entry->path = excache_resolve(cmd);
+    entry->fd   = -1;
+    if (entry->path)
+        entry->fd = open(entry->path, O_PATH | O_CLOEXEC);
+
+    entry->next = buckets[h];
+    buckets[h] = entry;
+
+    return entry;
+}
+
+void excache_flush(void)
+{
+    exec_entry *entry, *next;
+
+    for (int i = 0; i < EXCACHE_BUCKETS; ++i) {
+        for (entry = buckets[i]; entry; entry = next) {
+            next = entry->next;
+
+            if (entry->fd != -1)
+                close(entry->fd);
+            free(entry->name);
+            free(entry->path);
+            free(entry);
+        }
+        buckets[i] = NULL;
+    }
+
+    free(cached_path);
+    cached_path = NULL;
+}
+
+void excache_revalidate(void)
+{
+    const char *path_env = getenv("PATH");
+    const char *dir;
+    const char *end;
+    char buf[4096];
+    struct stat st;
+    int i, exist;
+
+    if (!path_env)
+        path_env = "";
+
+    if (!cached_path || strcmp(cached_path, path_env)) {
+        excache_flush();
+        excache_snapshot(path_env);
+        return;
+    }
+
+    // Adding or removing a file changes the mtime of its directory
+    for (i = 0, dir = path_env; i < cached_dirs_len; ++i, dir = end + 1) {
+        end = path_dir_name(dir, buf, sizeof(buf));
+
+        exist = !stat(buf, &st);
+
+        if (exist != cached_dirs[i].exist ||
+            (exist && (st.st_mtim.tv_sec  != cached_dirs[i].mtime.tv_sec ||
+                       st.st_mtim.tv_nsec != cached_dirs[i].mtime.tv_nsec))) {
+            excache_flush();
+            excache_snapshot(path_env);
+            return;
+        }
+    }
+}
@@ -0,0 +1,174 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <spawn.h>
+#include <signal.h>
+#include <sys/wait.h>
+
+#include "launch.h"
+
+// declared in unistd.h
+extern char** environ;
+
+#ifdef USE_FORK_LAUNCH
+int launch_mode = LAUNCH_FORK;
+#else
+int launch_mode = LAUNCH_SPAWN;
+#endif
+
+void launch_attr_init(launch_attr *attr)
+{
+    attr->fd_in  = -1;
+    attr->fd_out = -1;
+    attr->fd_err = -1;
+    attr->close_fds = NULL;
+    attr->close_len = 0;
+    attr->exec_fd = -1;
+}
+
+// Whether fd is one of the source fds which have been handled
+static int launch_src_seen(launch_attr *attr, int fd, int idx)
+{
+    int src[3] = {attr->fd_in, attr->fd_out, attr->fd_err};
+
+    for (int i = 0; i < idx; ++i) {
+        if (src[i] == fd)
+            return 1;
+    }
+
+    return 0;
+}
+
+static pid_t launch_spawn(char *file, char **argv, launch_attr *attr)
+{
+    posix_spawn_file_actions_t fa;
+    posix_spawnattr_t sa;
+    sigset_t mask, def;
+    int src[3] = {attr->fd_in, attr->fd_out, attr->fd_err};
+    pid_t pid;
+    int err;
+
+    posix_spawn_file_actions_init(&fa);
+
+    // Close other pipes
+    for (int i = 0; i < attr->close_len; ++i) {
+        posix_spawn_file_actions_addclose(&fa, attr->close_fds[i]);
+    }
+
+    // Wire stdin, stdout and stderr
+    for (int i = 0; i < 3; ++i) {
+        if (src[i] != -1)
+            posix_spawn_file_actions_adddup2(&fa, src[i], i);
+    }
+
+    // Close the wired fds, they are reachable through 0, 1 and 2 now
+    for (int i = 0; i < 3; ++i) {
+        if (src[i] > STDERR_FILENO && !launch_src_seen(attr, src[i], i))
+            posix_spawn_file_actions_addclose(&fa, src[i]);
+    }
+
+    // The shell keeps SIGCHLD blocked and ignores SIGPIPE,
+    // children start with neither
+    sigemptyset(&mask);
+    sigemptyset(&def);
+    sigaddset(&def, SIGPIPE);
+    posix_spawnattr_init(&sa);
+    posix_spawnattr_setsigmask(&sa, &mask);
+    posix_spawnattr_setsigdefault(&sa, &def);
+    posix_spawnattr_setflags(&sa, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETSIGDEF);
+
+    err = posix_spawnp(&pid, file, &fa, &sa, argv, environ);
+
+    posix_spawnattr_destroy(&sa);
+    posix_spawn_file_actions_destroy(&fa);
+
+    if (err) {
+        errno = err;
+        return -1;
+    }
+
+    return pid;
+}
+
+static pid_t launch_fork(char *file, char **argv, launch_attr *attr)
+{
+    int src[3] = {attr->fd_in, attr->fd_out, attr->fd_err};
+    sigset_t mask;
+    int err_pipe[2];
+    pid_t pid;
+    int err;
+    ssize_t n;
+
+    // Report exec failure back to the parent through a close-on-exec pipe
+    if (pipe2(err_pipe, O_CLOEXEC)) {
+        return -1;
+    }
+
+    if ((pid = fork()) > 0) {
+        // Parent process
+        close(err_pipe[1]);
+
+        n = read(err_pipe[0], &err, sizeof(err));
+        close(err_pipe[0]);
+
+        if (n == sizeof(err)) {
+            // exec failed, reap the child right away
+            waitpid(pid, NULL, 0);
+            errno = err;
+            return -1;
+        }
+
+        return pid;
+    } else if (!pid) {
+        // Child process
+        close(err_pipe[0]);
+
+        signal(SIGPIPE, SIG_DFL);
+        sigemptyset(&mask);
+        sigprocmask(SIG_SETMASK, &mask, NULL);
+
+        for (int i = 0; i < attr->close_len; ++i) {
+            close(attr->close_fds[i]);
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if (src[i] != -1)
+                dup2(src[i], i);
+        }
+
+        for (int i = 0; i < 3; ++i) {
+            if (src[i] > STDERR_FILENO && !launch_src_seen(attr, src[i], i))
+                close(src[i]);
+        }
+
+        if (attr->exec_fd != -1)
+            execveat(attr->exec_fd, "", argv, environ, AT_EMPTY_PATH);
+
+        // Scripts cannot be run through a close-on-exec fd
+        execvp(file, argv);
+
+        err = errno;
+        write(err_pipe[1], &err, sizeof(err));
+        _exit(127);
+    }
+
+    // fork failed
+    err = errno;
+    close(err_pipe[0]);
+    close(err_pipe[1]);
+    errno = err;
+
+    return -1;
+}
+
+pid_t launch(char *file, char **argv, launch_attr *attr)
+{
+    if (launch_mode == LAUNCH_FORK) {
+        return launch_fork(file, argv, attr);
+    }
+
+    return launch_spawn(file, argv, attr);
+}
@@ -0,0 +1,47 @@
+#include "lexer.h"
+
+#define ASCII_SPACE 0x20
+
+static int lexer_kind(const char *tk, int len)
+{
+    switch (tk[0]) {
+    case '|':
+        return len == 1 ? TOKEN_PIPE : TOKEN_PIPE_NUM;
+    case '!':
+        return TOKEN_PIPE_ERR;
+    case '>':
+        return TOKEN_REDIRECT;
+    default:
+        return TOKEN_WORD;
+    }
+}
+
+int lexer_split(char *cmd_line, int len, token *tokens)
+{
+    int cnt = 0;
+    int pos = 0;
+    int start;
+
+    while (pos < len) {
+        // Skip spaces
+        while (pos < len && cmd_line[pos] == ASCII_SPACE)
+            pos += 1;
+
+        if (pos >= len || !cmd_line[pos])
+            break;
+
+        start = pos;
+        while (pos < len && cmd_line[pos] && cmd_line[pos] != ASCII_SPACE)
+            pos += 1;
+
+        tokens[cnt].offset = start;
+        tokens[cnt].len    = pos - start;
+        tokens[cnt].kind   = lexer_kind(&cmd_line[start], pos - start);
+        cnt += 1;
+
+        if (pos < len)
+            cmd_line[pos++] = 0;
+    }
+
+    return cnt;
+}
@@ -0,0 +1,132 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+
+#include "linereader.h"
+
+void lr_init(line_reader *lr, int fd)
+{
+    lr->fd    = fd;
+    lr->buf   = malloc(LINEREADER_INIT_SIZE);
+    lr->size  = LINEREADER_INIT_SIZE;
+    lr->start = 0;
+    lr->end   = 0;
+    lr->scan  = 0;
+    lr->eof   = 0;
+    lr->idle_fd = -1;
+    lr->idle_cb = NULL;
+}
+
+void lr_release(line_reader *lr)
+{
+    free(lr->buf);
+    lr->buf  = NULL;
+    lr->size = 0;
+}
+
+void lr_set_idle(line_reader *lr, int fd, void (*cb)(void))
+{
+    lr->idle_fd = fd;
+    lr->idle_cb = cb;
+}
+
+// Wait until lr->fd is readable, serving idle_fd meanwhile
+static void lr_wait_input(line_reader *lr)
+{
+    struct pollfd pfd[2] = {
+        {.fd = lr->fd, .events = POLLIN},
+        {.fd = lr->idle_fd, .events = POLLIN},
+    };
+
+    if (lr->idle_fd == -1)
+        return;
+
+    while (1) {
+        if (poll(pfd, 2, -1) == -1) {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+
+        if (pfd[1].revents)
+            lr->idle_cb();
+
+        if (pfd[0].revents)
+            return;
+    }
+}
+
+// Make room for more input at the end of buf
+static void lr_make_room(line_reader *lr)
+{
+    if (lr->start) {
+        // Drop consumed lines
+        memmove(lr->buf, lr->buf + lr->start, lr->end - lr->start);
+        lr->end  -= lr->start;
+        lr->scan -= lr->start;
+        lr->start = 0;
+    }
+
+    // Keep one byte for the NUL of an unterminated last line
+    if (lr->size - lr->end < 2) {
+        lr->size *= 2;
+        lr->buf = realloc(lr->buf, lr->size);
+    }
+}
+
+int lr_read_line(line_reader *lr, char **line)
+{
+    char *nl;
+    ssize_t n;
+    int len;
+
+    while (1) {
+        // Only look at bytes which have not been scanned yet
+        nl = memchr(lr->buf + lr->scan, '\n', lr->end - lr->scan);
+        if (nl) {
+            *nl = 0;
+            break;
+        }
+        lr->scan = lr->end;
+
+        if (lr->eof) {
+            if (lr->start == lr->end)
+                return -1;
+
+            // Last line without newline
+            nl = lr->buf + lr->end;
+            *nl = 0;
+            lr->end += 1;
+            break;
+        }
+
+        lr_make_room(lr);
+        lr_wait_input(lr);
+
+        n = read(lr->fd, lr->buf + lr->end, lr->size - lr->end - 1);
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;
+            lr->eof = 1;
+        } else if (n == 0) {
+            lr->eof = 1;
+        } else {
+            lr->end += n;
+        }
+    }
+
+    *line = lr->buf + lr->start;
+    len = nl - *line;
+
+    lr->start = lr->scan = nl - lr->buf + 1;
+
+    // CRLF
+    if (len && (*line)[len - 1] == '\r') {
+        len -= 1;
+        (*line)[len] = 0;
+    }
+
+    return len;
+}
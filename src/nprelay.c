@@ -0,0 +1,338 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+
+#include "nprelay.h"
+
+#define RELAY_MAX_EVENTS 64
+#define RELAY_PAGE_SIZE  4096
+
+static int relay_ep = -1;
+
+// Handoff requests from the shell, served between event batches
+static int relay_evfd = -1;
+static pthread_mutex_t relay_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t relay_cond = PTHREAD_COND_INITIALIZER;
+static np_relay *relay_req;
+static int relay_resp;
+static int relay_done;
+
+// Event of the forwarding pipe of r, tagged by the lowest pointer bit
+#define RELAY_DST_TAG 1UL
+
+static void relay_free(np_relay *r)
+{
+    if (r->src != -1) {
+        epoll_ctl(relay_ep, EPOLL_CTL_DEL, r->src, NULL);
+        close(r->src);
+    }
+    if (r->dst != -1) {
+        epoll_ctl(relay_ep, EPOLL_CTL_DEL, r->dst, NULL);
+        close(r->dst);
+    }
+    if (r->memfd != -1)
+        close(r->memfd);
+    free(r);
+}
+
+// Stop polling src at EOF, level-triggered EPOLLHUP would spin
+static void relay_close_src(np_relay *r)
+{
+    epoll_ctl(relay_ep, EPOLL_CTL_DEL, r->src, NULL);
+    close(r->src);
+    r->src = -1;
+    r->eof = 1;
+}
+
+// Poll dst for room while spilled data is left to forward
+static void relay_watch_dst(np_relay *r)
+{
+    struct epoll_event ev = {
+        .events = r->sent < r->len ? EPOLLOUT : 0,
+        .data.ptr = (void *)((unsigned long)r | RELAY_DST_TAG),
+    };
+
+    epoll_ctl(relay_ep, EPOLL_CTL_MOD, r->dst, &ev);
+}
+
+// Move what is in the pipe to the memfd
+// return -1 if the pipe can not be spilled
+static int relay_spill(np_relay *r)
+{
+    ssize_t n;
+
+    if (r->src == -1)
+        return 0;
+
+    if (r->memfd == -1 && (r->memfd = memfd_create("numbered_pipe", MFD_CLOEXEC)) == -1)
+        return -1;
+
+    while ((n = splice(r->src, NULL, r->memfd, &r->len, NPRELAY_CHUNK,
+                       SPLICE_F_MOVE | SPLICE_F_NONBLOCK)) > 0)
+        ;
+
+    if (n == 0) {
+        relay_close_src(r);
+    } else if (errno != EAGAIN) {
+        return -1;
+    }
+
+    return 0;
+}
+
+// Move spilled data to the reader
+// return 1 once everything is forwarded, -1 if the reader is gone
+static int relay_forward(np_relay *r)
+{
+    loff_t keep;
+    ssize_t n;
+
+    while (r->sent < r->len) {
+        n = splice(r->memfd, &r->sent, r->dst, NULL, r->len - r->sent,
+                   SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (n <= 0) {
+            if (n == -1 && errno == EAGAIN)
+                break;
+            return -1;
+        }
+    }
+
+    // Give back memory of forwarded data
+    keep = r->sent & ~(loff_t)(RELAY_PAGE_SIZE - 1);
+    if (keep > r->punched) {
+        fallocate(r->memfd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE,
+                  r->punched, keep - r->punched);
+        r->punched = keep;
+    }
+
+    return r->eof && r->sent == r->len;
+}
+
+// Blocking reads from fd again
+static int relay_unblock(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+    return fd;
+}
+
+static int relay_serve_handoff(np_relay *r)
+{
+    struct epoll_event ev = {.events = 0};
+    int fwd[2];
+    int fd;
+
+    // Take everything written so far, the pipe stays as it is on failure
+    relay_spill(r);
+
+    if (r->memfd == -1) {
+        // Nothing spilled, the pipe is read as is
+        fd = r->src;
+        if (fd != -1) {
+            epoll_ctl(relay_ep, EPOLL_CTL_DEL, fd, NULL);
+            relay_unblock(fd);
+            r->src = -1;
+        } else {
+            fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+        }
+        relay_free(r);
+        return fd;
+    }
+
+    if (r->eof) {
+        // Writers are done, the memfd is read from the start
+        fd = r->memfd;
+        r->memfd = -1;
+        lseek(fd, 0, SEEK_SET);
+        relay_free(r);
+        return fd;
+    }
+
+    // Writers are running, keep spilling and forward to a new pipe
+    if (pipe2(fwd, O_CLOEXEC)) {
+        fd = relay_unblock(r->src);
+        epoll_ctl(relay_ep, EPOLL_CTL_DEL, fd, NULL);
+        r->src = -1;
+        relay_free(r);
+        return fd;
+    }
+
+    r->dst = fwd[1];
+    fcntl(r->dst, F_SETFL, O_NONBLOCK);
+    ev.data.ptr = (void *)((unsigned long)r | RELAY_DST_TAG);
+    epoll_ctl(relay_ep, EPOLL_CTL_ADD, r->dst, &ev);
+
+    if (relay_forward(r) == -1) {
+        relay_free(r);
+    } else {
+        relay_watch_dst(r);
+    }
+
+    return fwd[0];
+}
+
+static void relay_event(np_relay *r, int is_dst, unsigned int events)
+{
+    if (is_dst && (events & (EPOLLERR | EPOLLHUP))) {
+        // The reader is gone, writers get EPIPE
+        relay_free(r);
+        return;
+    }
+
+    if (!is_dst) {
+        if (relay_spill(r)) {
+            // Out of memory, writers block on the pipe as they would
+            // without the relay
+            epoll_ctl(relay_ep, EPOLL_CTL_DEL, r->src, NULL);
+        }
+
+        // Spilled data waits for the handoff
+        if (r->dst == -1)
+            return;
+    }
+
+    if (relay_forward(r)) {
+        // Done, or the reader is gone
+        relay_free(r);
+        return;
+    }
+
+    relay_watch_dst(r);
+}
+
+static void* relay_thread(void *arg)
+{
+    struct epoll_event evs[RELAY_MAX_EVENTS];
+    unsigned long tag;
+    uint64_t cnt;
+    int n;
+
+    while (1) {
+        n = epoll_wait(relay_ep, evs, RELAY_MAX_EVENTS, -1);
+
+        for (int i = 0; i < n; ++i) {
+            if (!evs[i].data.ptr) {
+                read(relay_evfd, &cnt, sizeof(cnt));
+                continue;
+            }
+
+            tag = (unsigned long)evs[i].data.ptr;
+            relay_event((np_relay *)(tag & ~RELAY_DST_TAG), tag & RELAY_DST_TAG,
+                        evs[i].events);
+        }
+
+        // Relays of this batch are not referenced anymore, they can be
+        // released by the handoff
+        pthread_mutex_lock(&relay_lock);
+        if (relay_req) {
+            relay_resp = relay_serve_handoff(relay_req);
+            relay_req = NULL;
+            relay_done = 1;
+            pthread_cond_signal(&relay_cond);
+        }
+        pthread_mutex_unlock(&relay_lock);
+    }
+
+    return NULL;
+}
+
+// Start the relay thread on first use
+// return -1 if the relay is not available
+static int relay_init(void)
+{
+    static int failed;
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    pthread_attr_t attr;
+    pthread_t thread;
+    int err;
+
+    if (relay_ep != -1)
+        return 0;
+    if (failed)
+        return -1;
+
+    failed = 1;
+
+    if ((relay_ep = epoll_create1(EPOLL_CLOEXEC)) == -1)
+        return -1;
+
+    if ((relay_evfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK)) == -1 ||
+        epoll_ctl(relay_ep, EPOLL_CTL_ADD, relay_evfd, &ev)) {
+        close(relay_ep);
+        relay_ep = -1;
+        return -1;
+    }
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    err = pthread_create(&thread, &attr, relay_thread, NULL);
+    pthread_attr_destroy(&attr);
+
+    if (err) {
+        close(relay_evfd);
+        close(relay_ep);
+        relay_ep = -1;
+        return -1;
+    }
+
+    failed = 0;
+
+    return 0;
+}
+
+np_relay* relay_add(int fd)
+{
+    struct epoll_event ev = {.events = EPOLLIN};
+    np_relay *r;
+
+    if (relay_init())
+        return NULL;
+
+    r = malloc(sizeof(np_relay));
+    r->src = fd;
+    r->memfd = -1;
+    r->len = 0;
+    r->dst = -1;
+    r->sent = 0;
+    r->punched = 0;
+    r->eof = 0;
+
+    // The relay thread owns r once it is polled
+    fcntl(fd, F_SETFD, FD_CLOEXEC);
+    fcntl(fd, F_SETFL, O_NONBLOCK);
+    ev.data.ptr = r;
+    if (epoll_ctl(relay_ep, EPOLL_CTL_ADD, fd, &ev)) {
+        free(r);
+        relay_unblock(fd);
+        return NULL;
+    }
+
+    return r;
+}
+
+int relay_handoff(np_relay *r)
+{
+    uint64_t one = 1;
+    int fd;
+
+    pthread_mutex_lock(&relay_lock);
+
+    relay_req = r;
+    relay_done = 0;
+    write(relay_evfd, &one, sizeof(one));
+
+    while (!relay_done)
+        pthread_cond_wait(&relay_cond, &relay_lock);
+
+    fd = relay_resp;
+
+    pthread_mutex_unlock(&relay_lock);
+
+    return fd;
+}
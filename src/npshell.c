@@ -1,28 +1,67 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <unistd.h>
 
 #include "sys_variable.h"
 #include "prompt.h"
 #include "cmd.h"
+#include "reaper.h"
+#include "script.h"
+#include "inproc.h"
+#include "optimize.h"
 
 void init(void);
 
-int main(void)
+int batch_run(const char *path);
+
+int main(int argc, char **argv)
 {
-    char cmd_line[MAX_CMDLINE_LEN] = { 0 };
+    line_reader lr;
+    char *cmd_line;
     int cmd_line_len;
     cmd_node *cmd;
+    char *script_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "dFf:")) != -1) {
+        switch (opt) {
+        case 'f':
+            script_path = optarg;
+            break;
+        case 'd':
+            // Log pipeline rewrites
+            opt_debug = 1;
+            break;
+        case 'F':
+            // Run cat and echo stages in the shell
+            inproc_enabled = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-dF] [-f script]\n", argv[0]);
+            return 1;
+        }
+    }
 
     // Initialization
     init();
 
+    // Non-interactive batch mode
+    if (script_path) {
+        return batch_run(script_path);
+    }
+    lr_init(&lr, STDIN_FILENO);
+    lr_set_idle(&lr, reaper_fd(), reaper_drain);
+
     // Main shell loop
     while (1) {
+        // Reaping exited children
+        reaper_drain();
+
         // Outputing Prompt
         prompt();
 
         // Reading command
-        cmd_line_len = cmd_read(cmd_line);
+        cmd_line_len = cmd_read(&lr, &cmd_line);
 
         if (!cmd_line_len) {
             // Empty command
@@ -30,15 +69,15 @@ int main(void)
         }
 
         // Parsing command
-        cmd = cmd_parse(cmd_line);
+        cmd = cmd_parse(cmd_line, cmd_line_len);
 
         // Debug
         // if (cmd) {
         //     for (cmd_node *c = cmd; c; c = c->next) {
         //         printf("cmd: %s\n", c->cmd);
         //         printf("argv_len: %d\n", c->argv_len);
-        //         for (argv_node *argv = c->argv; argv; argv = argv->next) {
-        //             printf("\t%s\n", argv->argv);
+        //         for (int i = 1; c->argv[i]; ++i) {
+        //             printf("\t%s\n", c->argv[i]);
         //         }
         //         if (c->rd_output)
         //             printf("rd_output: %s\n", c->rd_output);
@@ -54,6 +93,57 @@ int main(void)
     }
 }
 
+// Read the next non-empty line of sc and parse it
+// return 0 at the end of the script
+static int batch_next(script *sc, cmd_node **cmd)
+{
+    char *cmd_line;
+    int cmd_line_len;
+
+    do {
+        cmd_line_len = script_read_line(sc, &cmd_line);
+    } while (!cmd_line_len);
+
+    if (cmd_line_len == -1)
+        return 0;
+
+    *cmd = cmd_parse(cmd_line, cmd_line_len);
+
+    return 1;
+}
+
+int batch_run(const char *path)
+{
+    script sc;
+    cmd_pending pending;
+    cmd_node *cmd;
+    int has_cmd;
+    int status = 0;
+
+    if (script_open(&sc, path)) {
+        perror(path);
+        return 1;
+    }
+
+    // Numbered pipes due after the last line are never read
+    opt_last_line = script_count_lines(&sc);
+
+    has_cmd = batch_next(&sc, &cmd);
+
+    while (has_cmd) {
+        cmd_launch(cmd, &pending);
+
+        // Parse the next line while this one is running
+        has_cmd = batch_next(&sc, &cmd);
+
+        status = cmd_wait(&pending);
+    }
+
+    script_close(&sc);
+
+    return status;
+}
+
 void init(void)
 {
     // Initializing PATH
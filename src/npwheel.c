@@ -0,0 +1,138 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "npwheel.h"
+#include "reaper.h"
+
+#define NPWHEEL_MASK (NPWHEEL_SIZE - 1)
+
+// Whether target is covered by slots
+#define NPWHEEL_IN_WINDOW(npw, t) ((t) - (npw)->line < NPWHEEL_SIZE)
+
+void npw_init(np_wheel *npw)
+{
+    npw->line = 0;
+    for (int i = 0; i < NPWHEEL_SIZE; ++i) {
+        npw->slots[i] = NULL;
+    }
+    npw->overflow = NULL;
+    npw->all = NULL;
+    npw->len = 0;
+}
+
+static void npw_free(np_wheel *npw, np_node *np)
+{
+    // Unlink from all pipes list
+    *(np->all_pprev) = np->all_next;
+    if (np->all_next)
+        np->all_next->all_pprev = np->all_pprev;
+    npw->len -= 1;
+
+    if (np->fd[0] != -1)
+        close(np->fd[0]);
+    if (np->fd[1] != -1)
+        close(np->fd[1]);
+    reaper_untrack(np->plist);
+    pset_release(np->plist);
+    free(np);
+}
+
+np_node* npw_advance(np_wheel *npw)
+{
+    np_node **slot = &(npw->slots[npw->line & NPWHEEL_MASK]);
+    np_node *np;
+
+    // Release the pipe of the last line
+    if (*slot && (*slot)->target == npw->line) {
+        npw_free(npw, *slot);
+        *slot = NULL;
+    }
+
+    npw->line += 1;
+
+    // Pipes entering the window
+    while ((np = npw->overflow) && NPWHEEL_IN_WINDOW(npw, np->target)) {
+        npw->overflow = np->next;
+        np->next = NULL;
+        npw->slots[np->target & NPWHEEL_MASK] = np;
+    }
+
+    if (!(np = npw_find(npw, 0)))
+        return NULL;
+
+    // No more writers from the shell, lines writing to it are over
+    if (np->fd[1] != -1) {
+        close(np->fd[1]);
+        np->fd[1] = -1;
+    }
+
+    if (np->relay) {
+        np->fd[0] = relay_handoff(np->relay);
+        np->relay = NULL;
+    }
+
+    return np;
+}
+
+np_node* npw_find(np_wheel *npw, int numbered)
+{
+    unsigned long target = npw->line + numbered;
+    np_node *np;
+
+    if (NPWHEEL_IN_WINDOW(npw, target)) {
+        np = npw->slots[target & NPWHEEL_MASK];
+        return (np && np->target == target) ? np : NULL;
+    }
+
+    for (np = npw->overflow; np && np->target <= target; np = np->next) {
+        if (np->target == target)
+            return np;
+    }
+
+    return NULL;
+}
+
+np_node* npw_insert(np_wheel *npw, int numbered)
+{
+    np_node *new_np = malloc(sizeof(np_node));
+    np_node **ptr;
+
+    new_np->next = NULL;
+    new_np->plist = NULL;
+    new_np->target = npw->line + numbered;
+    pipe(new_np->fd);
+
+    // Room for bursts while the relay catches up, pipe pages are
+    // accounted per user so only for a few pipes
+    if (npw->len < NPRELAY_GROW_MAX)
+        fcntl(new_np->fd[1], F_SETPIPE_SZ, NPRELAY_PIPE_SIZE);
+
+    if ((new_np->relay = relay_add(new_np->fd[0])))
+        new_np->fd[0] = -1;
+
+    // Link to all pipes list
+    new_np->all_next = npw->all;
+    new_np->all_pprev = &(npw->all);
+    if (npw->all)
+        npw->all->all_pprev = &(new_np->all_next);
+    npw->all = new_np;
+    npw->len += 1;
+
+    if (NPWHEEL_IN_WINDOW(npw, new_np->target)) {
+        npw->slots[new_np->target & NPWHEEL_MASK] = new_np;
+        return new_np;
+    }
+
+    // Keep overflow sorted
+    ptr = &(npw->overflow);
+    while (*ptr && (*ptr)->target < new_np->target) {
+        ptr = &((*ptr)->next);
+    }
+    new_np->next = *ptr;
+    *ptr = new_np;
+
+    return new_np;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "optimize.h"
+#include "execcache.h"
+
+int opt_debug;
+unsigned long opt_last_line;
+
+// cat copying a pipe to stdout, the command must be found as the
+// shell would report it otherwise
+static int is_pass_through(cmd_node *cmd, int piped_in)
+{
+    return piped_in && !cmd->argv_len && !strcmp(cmd->cmd, "cat") &&
+           excache_lookup(cmd->cmd)->path;
+}
+
+// Stage whose only effect is its standard output
+static int is_pure(cmd_node *cmd, int piped_in)
+{
+    return is_pass_through(cmd, piped_in) ||
+           (!strcmp(cmd->cmd, "echo") && excache_lookup(cmd->cmd)->path);
+}
+
+// Whether all stages of cmd only write into a numbered pipe which is
+// never read
+static int is_dead(cmd_node *cmd, unsigned long line, int has_np_in)
+{
+    cmd_node *last = cmd;
+    int idx = 0;
+
+    if (!opt_last_line || has_np_in)
+        return 0;
+
+    for (; last->next; last = last->next) {
+        if (!is_pure(last, idx++))
+            return 0;
+    }
+
+    if (!is_pure(last, idx))
+        return 0;
+
+    return (last->pipetype == PIPE_NUM_STDOUT || last->pipetype == PIPE_NUM_OUTERR) &&
+           line + last->numbered > opt_last_line;
+}
+
+cmd_node* opt_pipeline(cmd_node *cmd, unsigned long line, int has_np_in)
+{
+    cmd_node *prev, *cur;
+    int stage = 1;
+
+    if (!cmd || cmd->builtin != -1)
+        return cmd;
+
+    if (is_dead(cmd, line, has_np_in)) {
+        if (opt_debug)
+            fprintf(stderr, "[opt] line %lu: dropped %d stages, output is never read\n",
+                    line, cmd->cmd_len);
+        return NULL;
+    }
+
+    // cat in the middle of a pipeline, the previous stage writes to the
+    // next one directly
+    for (prev = cmd; (cur = prev->next); ) {
+        stage += 1;
+
+        if (prev->pipetype == PIPE_ORDINARY && cur->pipetype == PIPE_ORDINARY &&
+            cur->next && is_pass_through(cur, 1)) {
+            if (opt_debug)
+                fprintf(stderr, "[opt] line %lu: elided cat at stage %d\n", line, stage);
+
+            prev->next = cur->next;
+            cmd->cmd_len -= 1;
+        } else {
+            prev = cur;
+        }
+    }
+
+    return cmd;
+}
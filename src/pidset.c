@@ -0,0 +1,282 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "pidset.h"
+
+pid_set *closed_plist;
+
+// Free blocks of the slab, by size class.
+// The first word of a free block links to the next one.
+static void *slab_free[PSET_SLAB_CLASSES];
+static pid_set *slab_free_sets;
+
+static int slab_class(int cap)
+{
+    int k = 0;
+
+    while ((PSET_MIN_CAP << k) < cap)
+        k += 1;
+
+    return k;
+}
+
+void pset_slab_init(void)
+{
+    char *mem = malloc(PSET_SLAB_SIZE);
+    size_t left = PSET_SLAB_SIZE;
+    size_t size;
+
+    // Carve one block of each class, then fill up with small blocks
+    for (int k = PSET_SLAB_CLASSES - 1; k >= 0; --k) {
+        size = sizeof(pid_slot) * (PSET_MIN_CAP << k);
+        if (size > left / 2)
+            continue;
+
+        *(void **)mem = slab_free[k];
+        slab_free[k] = mem;
+        mem  += size;
+        left -= size;
+    }
+
+    size = sizeof(pid_slot) * PSET_MIN_CAP;
+    while (left >= size + sizeof(pid_set)) {
+        *(void **)mem = slab_free[0];
+        slab_free[0] = mem;
+        mem  += size;
+        left -= size;
+
+        *(void **)mem = slab_free_sets;
+        slab_free_sets = (pid_set *)mem;
+        mem  += sizeof(pid_set);
+        left -= sizeof(pid_set);
+    }
+}
+
+static pid_slot* slab_alloc_slots(int cap)
+{
+    int k = slab_class(cap);
+    void *block;
+
+    if (k < PSET_SLAB_CLASSES && slab_free[k]) {
+        block = slab_free[k];
+        slab_free[k] = *(void **)block;
+    } else {
+        block = malloc(sizeof(pid_slot) * cap);
+    }
+
+    memset(block, 0, sizeof(pid_slot) * cap);
+
+    return block;
+}
+
+static void slab_free_slots(pid_slot *slots, int cap)
+{
+    int k = slab_class(cap);
+
+    // Blocks out of the slab classes always come from malloc
+    if (k >= PSET_SLAB_CLASSES) {
+        free(slots);
+        return;
+    }
+
+    // Blocks of the slab classes are recycled, whoever allocated them
+    *(void **)slots = slab_free[k];
+    slab_free[k] = slots;
+}
+
+static inline int pset_hash(pid_t pid, int cap)
+{
+    return ((unsigned int)pid * 2654435761u) & (cap - 1);
+}
+
+pid_set* pset_init()
+{
+    pid_set *pset;
+
+    if (slab_free_sets) {
+        pset = slab_free_sets;
+        slab_free_sets = *(pid_set **)pset;
+    } else {
+        pset = malloc(sizeof(pid_set));
+    }
+
+    pset->slots = slab_alloc_slots(PSET_MIN_CAP);
+    pset->cap   = PSET_MIN_CAP;
+    pset->len   = 0;
+    pset->used  = 0;
+
+    return pset;
+}
+
+void pset_release(pid_set *pset)
+{
+    if (!pset)
+        return;
+
+    slab_free_slots(pset->slots, pset->cap);
+
+    *(pid_set **)pset = slab_free_sets;
+    slab_free_sets = pset;
+}
+
+// Insert into a table known to have room and not to contain pid
+static void pset_put(pid_slot *slots, int cap, pid_slot *slot)
+{
+    int i = pset_hash(slot->pid, cap);
+
+    while (slots[i].pid != PSET_EMPTY)
+        i = (i + 1) & (cap - 1);
+
+    slots[i] = *slot;
+}
+
+static void pset_rehash(pid_set *pset, int cap)
+{
+    pid_slot *slots = slab_alloc_slots(cap);
+
+    for (int i = 0; i < pset->cap; ++i) {
+        if (pset->slots[i].pid > 0)
+            pset_put(slots, cap, &(pset->slots[i]));
+    }
+
+    slab_free_slots(pset->slots, pset->cap);
+
+    pset->slots = slots;
+    pset->cap   = cap;
+    pset->used  = pset->len;
+}
+
+// return the slot holding pid, -1 if not found
+static int pset_find(pid_set *pset, pid_t pid)
+{
+    int i = pset_hash(pid, pset->cap);
+
+    while (pset->slots[i].pid != PSET_EMPTY) {
+        if (pset->slots[i].pid == pid)
+            return i;
+        i = (i + 1) & (pset->cap - 1);
+    }
+
+    return -1;
+}
+
+void pset_insert(pid_set *pset, pid_t pid)
+{
+    pset_insert_val(pset, pid, 0);
+}
+
+void pset_insert_val(pid_set *pset, pid_t pid, int val)
+{
+    int i;
+
+    if ((i = pset_find(pset, pid)) != -1) {
+        pset->slots[i].val = val;
+        return;
+    }
+
+    // Keep load factor under 1/2
+    if ((pset->used + 1) * 2 > pset->cap) {
+        if ((pset->len + 1) * 4 > pset->cap)
+            pset_rehash(pset, pset->cap * 2);
+        else
+            pset_rehash(pset, pset->cap);
+    }
+
+    i = pset_hash(pid, pset->cap);
+    while (pset->slots[i].pid > 0)
+        i = (i + 1) & (pset->cap - 1);
+
+    if (pset->slots[i].pid == PSET_EMPTY)
+        pset->used += 1;
+
+    pset->slots[i].pid = pid;
+    pset->slots[i].val = val;
+    pset->len += 1;
+}
+
+int pset_delete(pid_set *pset, pid_t pid)
+{
+    return pset_take(pset, pid, NULL);
+}
+
+int pset_take(pid_set *pset, pid_t pid, int *val)
+{
+    int i;
+
+    if (!pset || !pset->len)
+        return 0;
+
+    i = pset_find(pset, pid);
+    if (i == -1)
+        return 0;
+
+    if (val)
+        *val = pset->slots[i].val;
+
+    pset->slots[i].pid = PSET_DELETED;
+    pset->len -= 1;
+
+    // Nothing left, drop deleted slots as well
+    if (!pset->len)
+        pset_clear(pset);
+
+    return 1;
+}
+
+int pset_contains(pid_set *pset, pid_t pid)
+{
+    return pset_find(pset, pid) != -1;
+}
+
+void pset_clear(pid_set *pset)
+{
+    memset(pset->slots, 0, sizeof(pid_slot) * pset->cap);
+    pset->len  = 0;
+    pset->used = 0;
+}
+
+void pset_merge(pid_set *pset1, pid_set *pset2)
+{
+    pid_set tmp;
+    pid_t pid;
+    int pos = 0;
+
+    if (!pset1->len) {
+        // Swap tables
+        tmp = *pset1;
+        *pset1 = *pset2;
+        *pset2 = tmp;
+        return;
+    }
+
+    while ((pid = pset_next(pset2, &pos))) {
+        pset_insert_val(pset1, pid, pset2->slots[pos - 1].val);
+    }
+
+    pset_clear(pset2);
+}
+
+void pset_delete_intersect(pid_set *pset1, pid_set *pset2)
+{
+    pid_set *small = pset1->len < pset2->len ? pset1 : pset2;
+    pid_set *large = small == pset1 ? pset2 : pset1;
+    pid_t pid;
+    int pos = 0;
+
+    while (small->len && large->len && (pid = pset_next(small, &pos))) {
+        if (pset_delete(large, pid))
+            pset_delete(small, pid);
+    }
+}
+
+pid_t pset_next(pid_set *pset, int *pos)
+{
+    while (*pos < pset->cap) {
+        pid_t pid = pset->slots[(*pos)++].pid;
+
+        if (pid > 0)
+            return pid;
+    }
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#define _GNU_SOURCE
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <signal.h>
+#include <sys/signalfd.h>
+#include <sys/wait.h>
+
+#include "reaper.h"
+#include "pidset.h"
+#include "sys_variable.h"
+
+sigset_t sigset_SIGCHLD;
+
+static int sig_fd = -1;
+
+// Pids claimed and not reaped yet
+static pid_set *live_plist;
+
+void reaper_init(void)
+{
+    sigemptyset(&sigset_SIGCHLD);
+    sigaddset(&sigset_SIGCHLD, SIGCHLD);
+
+    sigprocmask(SIG_BLOCK, &sigset_SIGCHLD, NULL);
+    sig_fd = signalfd(-1, &sigset_SIGCHLD, SFD_NONBLOCK | SFD_CLOEXEC);
+
+    live_plist   = pset_init();
+    closed_plist = pset_init();
+}
+
+int reaper_fd(void)
+{
+    return sig_fd;
+}
+
+void reaper_track(pid_t pid)
+{
+    pset_insert(live_plist, pid);
+}
+
+void reaper_untrack(pid_set *pset)
+{
+    pid_t pid;
+    int pos = 0;
+
+    if (!pset)
+        return;
+
+    while ((pid = pset_next(pset, &pos))) {
+        if (!pset_delete(closed_plist, pid))
+            pset_delete(live_plist, pid);
+    }
+}
+
+// Exit status as a shell reports it
+static int reaper_status(int wstatus)
+{
+    if (WIFSIGNALED(wstatus))
+        return 128 + WTERMSIG(wstatus);
+
+    return WEXITSTATUS(wstatus);
+}
+
+// Record a reaped child
+static void reaper_record(pid_t pid, int status)
+{
+    // Nobody is interested in unclaimed children
+    if (pset_delete(live_plist, pid))
+        pset_insert_val(closed_plist, pid, status);
+}
+
+void reaper_drain(void)
+{
+    struct signalfd_siginfo si;
+    siginfo_t info;
+
+    // Signals coalesce, the signalfd only tells something has happened
+    while (read(sig_fd, &si, sizeof(si)) == sizeof(si))
+        ;
+
+    while (1) {
+        info.si_pid = 0;
+
+        if (waitid(P_ALL, 0, &info, WEXITED | WNOHANG) || !info.si_pid)
+            break;
+
+        if (info.si_code == CLD_EXITED)
+            reaper_record(info.si_pid, info.si_status);
+        else
+            reaper_record(info.si_pid, 128 + info.si_status);
+    }
+}
+
+void reaper_wait_any(void)
+{
+    pid_t pid;
+    int wstatus;
+
+    while ((pid = waitpid(-1, &wstatus, 0)) == -1 && errno == EINTR)
+        ;
+
+    if (pid > 0)
+        reaper_record(pid, reaper_status(wstatus));
+
+    reaper_drain();
+}
+
+int reaper_wait(pid_set *pset, pid_t last)
+{
+    pid_t pid;
+    int pos = 0;
+    int wstatus;
+    int status;
+    int last_status = 0;
+
+    while ((pid = pset_next(pset, &pos))) {
+        // Reaped already
+        if (!pset_take(closed_plist, pid, &status)) {
+            while (waitpid(pid, &wstatus, 0) == -1 && errno == EINTR)
+                ;
+            pset_delete(live_plist, pid);
+            status = reaper_status(wstatus);
+        }
+
+        if (pid == last)
+            last_status = status;
+    }
+
+    pset_clear(pset);
+
+    return last_status;
+}
@@ -0,0 +1,118 @@
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "script.h"
+
+int script_open(script *sc, const char *path)
+{
+    struct stat st;
+    int fd;
+
+    sc->data = NULL;
+    sc->size = 0;
+    sc->pos  = 0;
+    sc->tail = NULL;
+
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) == -1)
+        return -1;
+
+    if (fstat(fd, &st)) {
+        close(fd);
+        return -1;
+    }
+
+    if (st.st_size) {
+        // Private writable mapping, lines are NUL-terminated in place
+        sc->data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE, fd, 0);
+        if (sc->data == MAP_FAILED) {
+            sc->data = NULL;
+            close(fd);
+            return -1;
+        }
+        sc->size = st.st_size;
+
+        madvise(sc->data, sc->size, MADV_SEQUENTIAL);
+    }
+
+    close(fd);
+
+    return 0;
+}
+
+void script_close(script *sc)
+{
+    if (sc->data)
+        munmap(sc->data, sc->size);
+    free(sc->tail);
+
+    sc->data = NULL;
+    sc->tail = NULL;
+}
+
+int script_read_line(script *sc, char **line)
+{
+    char *start = sc->data + sc->pos;
+    char *nl;
+    int len;
+
+    if (sc->pos >= sc->size)
+        return -1;
+
+    nl = memchr(start, '\n', sc->size - sc->pos);
+
+    if (nl) {
+        *nl = 0;
+        len = nl - start;
+        sc->pos += len + 1;
+    } else {
+        // No room for NUL after the end of the mapping
+        len = sc->size - sc->pos;
+        sc->tail = malloc(len + 1);
+        memcpy(sc->tail, start, len);
+        sc->tail[len] = 0;
+        start = sc->tail;
+        sc->pos = sc->size;
+    }
+
+    // CRLF
+    if (len && start[len - 1] == '\r') {
+        len -= 1;
+        start[len] = 0;
+    }
+
+    *line = start;
+
+    return len;
+}
+
+unsigned long script_count_lines(script *sc)
+{
+    char *cur = sc->data + sc->pos;
+    char *end = sc->data + sc->size;
+    char *nl;
+    unsigned long count = 0;
+    size_t len;
+
+    while (cur < end) {
+        nl = memchr(cur, '\n', end - cur);
+        if (!nl)
+            nl = end;
+
+        // CRLF
+        len = nl - cur;
+        if (len && cur[len - 1] == '\r')
+            len -= 1;
+
+        if (len)
+            count += 1;
+
+        cur = nl + 1;
+    }
+
+    return count;
+}